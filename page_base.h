@@ -12,9 +12,14 @@
 typedef struct page_manager_t page_manager;
 typedef struct page_base_node_t page_base_node;
 typedef struct page_base_t page_base;
+typedef struct page_vlist_t page_vlist;
 
 typedef void (*create_page_t)(lv_obj_t *);
 typedef void (*page_state_callback)(const lv_obj_t *);
+typedef uint32_t (*page_save_state_t)(const lv_obj_t *, void *, uint32_t);
+typedef void (*page_restore_state_t)(lv_obj_t *, const void *, uint32_t);
+typedef void (*page_vlist_create_row_t)(lv_obj_t *);
+typedef void (*page_vlist_bind_t)(lv_obj_t *, uint32_t);
 
 typedef enum page_anim_type_e {
     PAGE_ANIM_NONE = 0,
@@ -58,8 +63,10 @@ typedef struct page_desc_t {
     page_state_callback on_will_disappear; /* 即将消失 */
     page_state_callback on_disappeared;    /* 设置为不可见 */
     page_state_callback on_will_unload;    /* 即将移除 */
-    page_state_callback on_unloaded;       /* 已经移除 */
+    page_state_callback on_unloaded;       /* 已经移出页面栈，lv_obj稍后删除，删除事件可能在此之后甚至页面重新创建之后执行 */
     page_anim_desc anim_desc;              /* 页面切换动画参数 */
+    page_save_state_t save_state;          /* 保存页面状态，返回写入字节数 */
+    page_restore_state_t restore_state;    /* 恢复页面状态，在create_page之后调用 */
 } page_desc;
 
 typedef enum {
@@ -80,6 +87,10 @@ typedef struct page_base_t {
     page_base_node *node; /* 保存页面在栈中地址，用于free */
     bool is_push;         /* 由push发起动作 */
     bool is_anim_busy;    /* 页面切换动画执行中 */
+    bool is_restore;      /* 由restore发起动作，跳过动画 */
+    void *saved_state;    /* restore时尚未创建页面的状态数据 */
+    uint32_t saved_size;  /* 状态数据长度 */
+    page_vlist *vlist;    /* 页面中的虚拟列表 */
 } page_base;
 
 #endif /* __PAGE_BASE_H__ */
@@ -0,0 +1,253 @@
+#include "page_base.h"
+#include "page_manager.h"
+#include "page_log.h"
+#include "page_internal.h"
+#include "src/core/lv_obj.h"
+#include "src/core/lv_obj_tree.h"
+#include "src/misc/lv_anim.h"
+#include "src/misc/lv_mem.h"
+#include "src/misc/lv_timer.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef PAGE_GC_PERIOD
+#define PAGE_GC_PERIOD 20 /* 回收定时器周期ms */
+#endif
+#ifndef PAGE_GC_CHUNK
+#define PAGE_GC_CHUNK 16 /* 每次最多删除的lv_obj数 */
+#endif
+#ifndef PAGE_GC_MAX_PENDING
+#define PAGE_GC_MAX_PENDING 3 /* 超过后页面切换中也继续删除 */
+#endif
+#ifndef PAGE_GC_MIN_FREE
+#if LV_MEM_CUSTOM == 0
+#define PAGE_GC_MIN_FREE (LV_MEM_SIZE / 8) /* lv_mem剩余低于此值时立即删除 */
+#else
+#define PAGE_GC_MIN_FREE 0
+#endif
+#endif
+
+static page_gc_node *gc_head = NULL;
+static page_gc_node *gc_tail = NULL;
+static uint32_t gc_pending = 0;
+static lv_timer_t *gc_timer = NULL;
+static lv_obj_t *gc_scr = NULL; /* 不加载的屏幕，待删除页面移到这里 */
+
+/**
+ * @brief Count objects in subtree, stop counting when more than limit
+ * @param obj Root of subtree
+ * @param limit Max number to count
+ * @return uint32_t Number of objects, limit + 1 if subtree is larger
+ */
+static uint32_t gc_count_objs(const lv_obj_t *obj, uint32_t limit)
+{
+    uint32_t cnt = 1;
+    uint32_t child_cnt = lv_obj_get_child_cnt(obj);
+    for (uint32_t i = 0; i < child_cnt && cnt <= limit; i++)
+        cnt += gc_count_objs(lv_obj_get_child(obj, i), limit - cnt);
+    return cnt;
+}
+
+/**
+ * @brief Delete children of obj from the last one, up to budget objects
+ *
+ * A subtree fitting in budget is deleted as a whole with lv_obj_del(), so
+ * its delete events run in lvgl order. Only larger subtrees are split.
+ * @param obj Parent object
+ * @param budget Max number of objects to delete
+ * @return uint32_t Number of objects deleted
+ */
+static uint32_t gc_del_children(lv_obj_t *obj, uint32_t budget)
+{
+    uint32_t cnt = 0;
+    while (cnt < budget && lv_obj_get_child_cnt(obj) > 0) {
+        lv_obj_t *child = lv_obj_get_child(obj, -1);
+        uint32_t size = gc_count_objs(child, budget - cnt);
+        if (size <= budget - cnt) {
+            free_page_styles(child);
+            lv_obj_del(child);
+            cnt += size;
+        } else {
+            cnt += gc_del_children(child, budget - cnt);
+        }
+    }
+    return cnt;
+}
+
+/**
+ * @brief Delete up to budget objects of queued page tree
+ * @param gcn Pointer to teardown queue node
+ * @param budget Max number of objects to delete
+ * @return uint32_t Number of objects deleted, gcn->lv_root is NULL when tree is done
+ */
+static uint32_t gc_del_objs(page_gc_node *gcn, uint32_t budget)
+{
+    uint32_t cnt = gc_del_children(gcn->lv_root, budget);
+    if (cnt < budget && lv_obj_get_child_cnt(gcn->lv_root) == 0) {
+        free_page_styles(gcn->lv_root);
+        lv_obj_del(gcn->lv_root);
+        gcn->lv_root = NULL;
+        cnt++;
+    }
+    return cnt;
+}
+
+/**
+ * @brief Delete whole queued page tree at once
+ * @param gcn Pointer to teardown queue node
+ */
+static void gc_del_all(page_gc_node *gcn)
+{
+    if (gcn->lv_root == NULL)
+        return;
+    free_page_styles(gcn->lv_root);
+    lv_obj_del(gcn->lv_root);
+    gcn->lv_root = NULL;
+}
+
+/**
+ * @brief Unlink node from teardown queue and free it
+ * @param pgcn Pointer to the link pointing to node
+ * @param prev Previous node, NULL if node is head
+ */
+static void gc_remove(page_gc_node **pgcn, page_gc_node *prev)
+{
+    page_gc_node *gcn = *pgcn;
+    *pgcn = gcn->next;
+    if (gc_tail == gcn)
+        gc_tail = prev;
+    gc_pending--;
+    page_free(gcn);
+}
+
+static void page_gc_timer_cb(lv_timer_t *t)
+{
+    if (gc_head == NULL) {
+        lv_timer_pause(t);
+        return;
+    }
+    // 页面切换中不回收，避免卡顿；等待的页面过多时每次只删除一小块
+    if (!is_page_anim_done() && gc_pending <= PAGE_GC_MAX_PENDING)
+        return;
+
+    uint32_t budget = PAGE_GC_CHUNK;
+    while (gc_head != NULL && budget > 0) {
+        budget -= gc_del_objs(gc_head, budget);
+        if (gc_head->lv_root == NULL)
+            gc_remove(&gc_head, NULL);
+    }
+    if (gc_head == NULL)
+        lv_timer_pause(t);
+}
+
+/**
+ * @brief Create teardown timer, called by page_manager_init()
+ */
+void page_gc_init(void)
+{
+    if (gc_timer != NULL)
+        return;
+    gc_scr = lv_obj_create(NULL);
+    gc_timer = gc_scr != NULL ? lv_timer_create(page_gc_timer_cb, PAGE_GC_PERIOD, NULL) : NULL;
+    if (gc_timer == NULL) {
+        p_warning("page_gc timer create failed, pages are deleted at once");
+        return;
+    }
+    lv_timer_pause(gc_timer);
+}
+
+/**
+ * @brief Detach unloaded page tree from screen and queue it for deletion
+ *
+ * Queued trees are deleted in chunks while no page transition is running,
+ * or on every tick once more than PAGE_GC_MAX_PENDING trees are queued.
+ * @param lv_root Root lv_obj of page
+ * @param desc Page description
+ */
+void page_gc_add(lv_obj_t *lv_root, page_desc *desc)
+{
+    lv_obj_add_flag(lv_root, LV_OBJ_FLAG_HIDDEN);
+
+    // free in gc_remove()
+    page_gc_node *gcn = gc_timer != NULL ? page_calloc(1, sizeof(page_gc_node)) : NULL;
+    if (gcn == NULL) {
+        // 无法排队时直接删除
+        free_page_styles(lv_root);
+        lv_obj_del(lv_root);
+        return;
+    }
+    lv_obj_set_parent(lv_root, gc_scr);
+    gcn->lv_root = lv_root;
+    gcn->desc = desc;
+    if (gc_tail == NULL)
+        gc_head = gcn;
+    else
+        gc_tail->next = gcn;
+    gc_tail = gcn;
+    gc_pending++;
+
+    // 内存不足时立即删除
+    if (page_gc_is_mem_low()) {
+        page_gc_flush();
+        return;
+    }
+    lv_timer_resume(gc_timer);
+}
+
+/**
+ * @brief Delete all queued page trees at once
+ */
+void page_gc_flush(void)
+{
+    while (gc_head != NULL) {
+        gc_del_all(gc_head);
+        gc_remove(&gc_head, NULL);
+    }
+}
+
+/**
+ * @brief Delete queued page trees of one page at once
+ * @param desc Page description
+ */
+void page_gc_flush_desc(page_desc *desc)
+{
+    page_gc_node **pgcn = &gc_head;
+    page_gc_node *prev = NULL;
+    while (*pgcn != NULL) {
+        if ((*pgcn)->desc == desc) {
+            gc_del_all(*pgcn);
+            gc_remove(pgcn, prev);
+        } else {
+            prev = *pgcn;
+            pgcn = &(*pgcn)->next;
+        }
+    }
+}
+
+/**
+ * @brief Determine lv_mem is running low and queued pages should be deleted
+ * Walks lv_mem pool, only called when a tree is queued and before a page is loaded.
+ * @return true free lv_mem below PAGE_GC_MIN_FREE
+ * @return false enough lv_mem, or lv_mem is not monitored
+ */
+bool page_gc_is_mem_low(void)
+{
+#if LV_MEM_CUSTOM == 0
+    if (PAGE_GC_MIN_FREE == 0)
+        return false;
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    return mon.free_size < PAGE_GC_MIN_FREE;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Get number of page trees waiting for deletion
+ * @return uint32_t Number of queued pages
+ */
+uint32_t page_gc_pending(void)
+{
+    return gc_pending;
+}
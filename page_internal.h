@@ -0,0 +1,39 @@
+#ifndef __PAGE_INTERNAL_H__
+#define __PAGE_INTERNAL_H__
+
+#include "page_base.h"
+#include <stddef.h>
+
+/* 页面管理器内部使用的内存分配，计入page_manager_stats */
+void *page_calloc(size_t n, size_t size);
+void page_free(void *);
+
+/* 页面切换动画是否结束，包括出栈页面 */
+bool is_page_anim_done(void);
+
+/* 出栈页面卸载完成 */
+void page_pop_done(page_base *);
+
+/* 释放lv_obj及其子节点上页面管理器创建的样式 */
+void free_page_styles(const lv_obj_t *);
+
+/* 页面状态切换时管理页面内虚拟列表的行对象 */
+void page_vlist_release(page_base *);
+void page_vlist_restore(page_base *);
+void page_vlist_free(page_base *);
+/* 虚拟列表占用的page_calloc分配数 */
+uint32_t page_vlist_alloc_cnt(const page_vlist *);
+
+typedef struct page_gc_node_t {
+    lv_obj_t *lv_root; /* 待删除的页面节点 */
+    page_desc *desc;   /* 页面描述 */
+    struct page_gc_node_t *next;
+} page_gc_node;
+
+/* 已卸载页面节点的延迟删除 */
+void page_gc_init(void);
+void page_gc_add(lv_obj_t *, page_desc *);
+void page_gc_flush_desc(page_desc *);
+bool page_gc_is_mem_low(void);
+
+#endif /* __PAGE_INTERNAL_H__ */
@@ -1,7 +1,9 @@
 #ifndef __PAGE_LOG_H__
 #define __PAGE_LOG_H__
 
+#ifndef LOG_ENABLE
 #define LOG_ENABLE 1
+#endif
 
 #if LOG_ENABLE
 #include <stdio.h>
@@ -1,8 +1,10 @@
 #include "page_manager.h"
 #include "lvgl.h"
 #include "page_log.h"
+#include "page_internal.h"
 #include "src/core/lv_obj_tree.h"
 #include "src/misc/lv_anim.h"
+#include "src/misc/lv_mem.h"
 #include "page_base.h"
 #include <stdbool.h>
 #include <stdlib.h>
@@ -10,6 +12,31 @@
 #include <unistd.h>
 
 static page_manager *default_page_manager = NULL;
+static page_base_node *page_out = NULL; /* 已出栈、正在消失的页面 */
+static uint32_t page_alloc_cnt = 0;
+static uint32_t page_free_cnt = 0;
+
+/**
+ * @brief calloc for memory owned by page manager, counted in page_manager_stats
+ */
+void *page_calloc(size_t n, size_t size)
+{
+    void *p = calloc(n, size);
+    if (p != NULL)
+        page_alloc_cnt++;
+    return p;
+}
+
+/**
+ * @brief free for memory allocated by page_calloc()
+ */
+void page_free(void *p)
+{
+    if (p == NULL)
+        return;
+    page_free_cnt++;
+    free(p);
+}
 
 /**
  * @brief Determine page description struct is valid
@@ -72,6 +99,23 @@ static bool find_page_desc_in_stack(page_desc *desc)
     return true;
 }
 
+/**
+ * @brief Find registered page description struct by name
+ * @param name Page name, not necessarily null-terminated
+ * @param len Length of name
+ * @return page_desc* Pointer to page description struct, NULL if not found
+ */
+static page_desc *find_page_desc_by_name(const char *name, uint32_t len)
+{
+    page_desc_node *pdn = default_page_manager->page_all;
+    while (pdn != NULL) {
+        if (strlen(pdn->desc->page_name) == len && memcmp(pdn->desc->page_name, name, len) == 0)
+            return pdn->desc;
+        pdn = pdn->next;
+    }
+    return NULL;
+}
+
 /**
  * @brief default_page_manager init and animation init
  * @return true init successful
@@ -88,6 +132,7 @@ bool page_manager_init(void)
         default_page_manager->page_all = NULL;
         default_page_manager->page_stack = NULL;
         page_anim_init();
+        page_gc_init();
         p_log("default_page_manager calloc success");
         return true;
     }
@@ -112,7 +157,7 @@ static bool page_register(page_desc *desc)
         return false;
     }
 
-    page_desc_node *new_pdb = calloc(1, sizeof(page_desc_node));
+    page_desc_node *new_pdb = page_calloc(1, sizeof(page_desc_node));
     if (new_pdb == NULL) {
         p_warning("page_desc_node calloc failed");
         return false;
@@ -160,15 +205,15 @@ bool page_uninstall(page_desc *desc)
         p_warning("%s: page is on the stack and cannot be unregister", __FUNCTION__);
         return false;
     }
+    // 等待删除的页面节点可能还有该页面的事件回调
+    page_gc_flush_desc(desc);
 
-    page_desc_node *pdn = default_page_manager->page_all;
-    page_desc_node *pdn_pre = default_page_manager->page_all;
-    while (pdn->desc != desc) {
-        pdn_pre = pdn;
-        pdn = pdn->next;
-    }
-    pdn_pre->next = pdn->next;
-    free(pdn);
+    page_desc_node **ppdn = &default_page_manager->page_all;
+    while ((*ppdn)->desc != desc)
+        ppdn = &(*ppdn)->next;
+    page_desc_node *pdn = *ppdn;
+    *ppdn = pdn->next;
+    page_free(pdn);
     return true;
 }
 
@@ -177,10 +222,13 @@ bool page_uninstall(page_desc *desc)
  * @return true finished
  * @return false not yet
  */
-static bool is_page_anim_done(void)
+bool is_page_anim_done(void)
 {
     bool top1 = false;
     bool top2 = false;
+    // 出栈页面消失动画结束前不能开始新的动画
+    if (page_out != NULL)
+        return false;
     if (default_page_manager->page_stack != NULL) {
         top1 = default_page_manager->page_stack->base.is_anim_busy;
         if (default_page_manager->page_stack->next != NULL)
@@ -210,7 +258,7 @@ page_base *page_push(page_desc *desc)
     }
 
     // free in do_unload()
-    page_base_node *new_pbn = calloc(1, sizeof(page_base_node));
+    page_base_node *new_pbn = page_calloc(1, sizeof(page_base_node));
     if (new_pbn == NULL) {
         p_error("page_base_node calloc failed");
         return NULL;
@@ -244,6 +292,16 @@ page_base *page_push(page_desc *desc)
     return &default_page_manager->page_stack->base;
 }
 
+/**
+ * @brief Called by do_unload() when page popped from stack is unloaded
+ * @param page Pointer to page
+ */
+void page_pop_done(page_base *page)
+{
+    if (page_out == page->node)
+        page_out = NULL;
+}
+
 /**
  * @brief Pop page from stack
  * @return page_base* Pointer to page in stack top
@@ -263,17 +321,340 @@ page_base *page_pop(void)
         return NULL;
     }
 
-    if (default_page_manager->page_stack->next != NULL)
+    bool is_lazy = false;
+    if (default_page_manager->page_stack->next != NULL) {
         default_page_manager->page_stack->next->base.is_push = false;
-    //  state: will appear->start appear anim->animation finished->appeared->avtivity
+        // 由restore记录但尚未创建的页面，出栈露出时才创建
+        if (default_page_manager->page_stack->next->base.lv_root == NULL) {
+            default_page_manager->page_stack->next->base.state = PAGE_STATE_LOAD;
+            is_lazy = true;
+        }
+    }
+    //  state: (load->)will appear->start appear anim->animation finished->appeared->avtivity
     page_state_run(&default_page_manager->page_stack->next->base);
+    // 新创建的页面需要放到出栈页面下方
+    if (is_lazy)
+        lv_obj_move_background(default_page_manager->page_stack->next->base.lv_root);
 
     page_base_node *pbn = default_page_manager->page_stack;
     pbn->base.is_push = false;
     default_page_manager->page_stack = pbn->next;
+    page_out = pbn;
 
     // avtivity->will disappear->start disappear anim->animation finishes->disappeared->->will_appear->unload
     page_state_run(&pbn->base);
 
     return &default_page_manager->page_stack->base;
 }
+
+/**
+ * @brief Find the page in stack which lv_obj belongs to
+ * @param obj Pointer to lv_obj
+ * @return page_base* Pointer to page, NULL if obj is not in any page
+ */
+page_base *page_find_by_obj(const lv_obj_t *obj)
+{
+    if (default_page_manager == NULL)
+        return NULL;
+    for (; obj != NULL; obj = lv_obj_get_parent(obj)) {
+        page_base_node *pbn = default_page_manager->page_stack;
+        while (pbn != NULL) {
+            if (pbn->base.lv_root == obj)
+                return &pbn->base;
+            pbn = pbn->next;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Serialize one stack node and the nodes below it, bottom first
+ * @param pbn Pointer to stack node
+ * @param buf Output buffer
+ * @param size Size of output buffer
+ * @param pos Write position in buf
+ * @return uint32_t Write position after this node, 0 if buf is too small
+ */
+static uint32_t stack_save_node(page_base_node *pbn, uint8_t *buf, uint32_t size, uint32_t pos)
+{
+    if (pbn->next != NULL) {
+        pos = stack_save_node(pbn->next, buf, size, pos);
+        if (pos == 0)
+            return 0;
+    }
+
+    uint32_t name_len = strlen(pbn->base.desc->page_name);
+    if (name_len > UINT8_MAX || pos + 1 + name_len + 2 > size)
+        return 0;
+    buf[pos++] = name_len;
+    memcpy(&buf[pos], pbn->base.desc->page_name, name_len);
+    pos += name_len;
+
+    uint32_t state_len = 0;
+    uint32_t state_max = size - pos - 2;
+    if (state_max > UINT16_MAX)
+        state_max = UINT16_MAX;
+    if (pbn->base.lv_root == NULL) {
+        // 页面尚未创建，原样保存restore时的状态
+        if (pbn->base.saved_size > state_max)
+            return 0;
+        state_len = pbn->base.saved_size;
+        if (state_len != 0)
+            memcpy(&buf[pos + 2], pbn->base.saved_state, state_len);
+    } else if (pbn->base.desc->save_state != NULL) {
+        state_len = pbn->base.desc->save_state(pbn->base.lv_root, &buf[pos + 2], state_max);
+        if (state_len > state_max)
+            return 0;
+    }
+    buf[pos++] = state_len & 0xff;
+    buf[pos++] = state_len >> 8;
+    return pos + state_len;
+}
+
+/**
+ * @brief Save page stack as page names and page states
+ *
+ * Format: page count(1B), then for each page from bottom to top:
+ * name length(1B), name, state length(2B, little endian), state.
+ * @param buf Output buffer
+ * @param size Size of output buffer
+ * @return uint32_t Bytes written, 0 on failure
+ */
+uint32_t page_stack_save(uint8_t *buf, uint32_t size)
+{
+    if (default_page_manager == NULL) {
+        p_warning("%s: default_page_manager is NULL", __FUNCTION__);
+        return 0;
+    }
+    if (buf == NULL || size == 0)
+        return 0;
+    if (!is_page_anim_done()) {
+        p_warning("page animation not finished");
+        return 0;
+    }
+
+    uint32_t cnt = 0;
+    for (page_base_node *pbn = default_page_manager->page_stack; pbn != NULL; pbn = pbn->next)
+        cnt++;
+    if (cnt > UINT8_MAX) {
+        p_warning("%s: page stack is too deep", __FUNCTION__);
+        return 0;
+    }
+    buf[0] = cnt;
+    if (cnt == 0)
+        return 1;
+
+    uint32_t pos = stack_save_node(default_page_manager->page_stack, buf, size, 1);
+    if (pos == 0)
+        p_warning("%s: buffer is too small", __FUNCTION__);
+    return pos;
+}
+
+/**
+ * @brief Free stack nodes which are not built yet
+ * @param pbn Pointer to first node
+ */
+static void free_restore_nodes(page_base_node *pbn)
+{
+    while (pbn != NULL) {
+        page_base_node *next = pbn->next;
+        page_free(pbn->base.saved_state);
+        page_free(pbn);
+        pbn = next;
+    }
+}
+
+/**
+ * @brief Restore page stack saved by page_stack_save()
+ *
+ * Only the top page is built, without animation. The pages below are
+ * recorded in stack and built when they are popped back to. Page stack
+ * must be empty and the last popped page must have finished disappearing.
+ * @param buf Data written by page_stack_save()
+ * @param size Size of data
+ * @return true successful
+ * @return false failed, page stack is unchanged
+ */
+bool page_stack_restore(const uint8_t *buf, uint32_t size)
+{
+    if (default_page_manager == NULL) {
+        p_warning("%s: default_page_manager is NULL", __FUNCTION__);
+        return false;
+    }
+    if (default_page_manager->page_stack != NULL) {
+        p_warning("%s: page stack is not empty", __FUNCTION__);
+        return false;
+    }
+    // 出栈页面可能还在消失，与restore的页面是同一个
+    if (!is_page_anim_done()) {
+        p_warning("page animation not finished");
+        return false;
+    }
+    if (buf == NULL || size == 0)
+        return false;
+
+    uint32_t cnt = buf[0];
+    uint32_t pos = 1;
+    page_base_node *top = NULL;
+    for (uint32_t i = 0; i < cnt; i++) {
+        if (pos + 1 > size || pos + 1 + buf[pos] + 2 > size)
+            goto err;
+        uint32_t name_len = buf[pos++];
+        page_desc *desc = find_page_desc_by_name((const char *)&buf[pos], name_len);
+        if (desc == NULL) {
+            p_warning("%s: page %.*s is not in pools", __FUNCTION__, (int)name_len, &buf[pos]);
+            goto err;
+        }
+        pos += name_len;
+        uint32_t state_len = buf[pos] | (buf[pos + 1] << 8);
+        pos += 2;
+        if (pos + state_len > size)
+            goto err;
+
+        // free in do_unload()
+        page_base_node *new_pbn = page_calloc(1, sizeof(page_base_node));
+        if (new_pbn == NULL) {
+            p_error("page_base_node calloc failed");
+            goto err;
+        }
+        if (state_len != 0) {
+            // free in do_load()
+            new_pbn->base.saved_state = page_calloc(1, state_len);
+            if (new_pbn->base.saved_state == NULL) {
+                p_error("page state calloc failed");
+                page_free(new_pbn);
+                goto err;
+            }
+            memcpy(new_pbn->base.saved_state, &buf[pos], state_len);
+            new_pbn->base.saved_size = state_len;
+        }
+        pos += state_len;
+        new_pbn->base.desc = desc;
+        new_pbn->base.lv_root = NULL;
+        new_pbn->base.state = PAGE_STATE_IDLE;
+        new_pbn->base.is_push = true;
+        new_pbn->base.node = new_pbn;
+        new_pbn->next = top;
+        top = new_pbn;
+    }
+
+    if (top == NULL)
+        return true;
+    default_page_manager->page_stack = top;
+    top->base.is_restore = true;
+    top->base.state = PAGE_STATE_LOAD;
+    //  state: load->will appear->appeared->avtivity
+    page_state_run(&top->base);
+    return true;
+
+err:
+    p_warning("%s: restore page stack failed", __FUNCTION__);
+    free_restore_nodes(top);
+    return false;
+}
+
+/**
+ * @brief Get memory usage of page manager and lvgl
+ * @param stats Output stats
+ */
+void page_manager_get_stats(page_manager_stats *stats)
+{
+    memset(stats, 0, sizeof(page_manager_stats));
+    stats->alloc_cnt = page_alloc_cnt;
+    stats->free_cnt = page_free_cnt;
+    if (default_page_manager != NULL) {
+        for (page_desc_node *pdn = default_page_manager->page_all; pdn != NULL; pdn = pdn->next)
+            stats->pool_cnt++;
+        for (page_base_node *pbn = default_page_manager->page_stack; pbn != NULL; pbn = pbn->next)
+            stats->stack_depth++;
+    }
+    stats->gc_pending = page_gc_pending();
+#if LV_MEM_CUSTOM == 0
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    stats->lv_mem_used = mon.total_size - mon.free_size;
+    stats->lv_mem_frag = mon.frag_pct;
+#endif
+}
+
+/**
+ * @brief Check page stack and page states, used by soak test after each step
+ *
+ * Besides structure of stack, when no animation is running the top page
+ * must be activity and covered pages must be hidden and waiting to appear,
+ * and every allocation of page manager must be owned by pool, stack, the page
+ * being popped or teardown queue.
+ * @return true all invariants hold
+ * @return false invariant violated, see error log
+ */
+bool page_manager_check(void)
+{
+    if (default_page_manager == NULL) {
+        p_warning("%s: default_page_manager is NULL", __FUNCTION__);
+        return false;
+    }
+
+    uint32_t live_cnt = page_gc_pending();
+    for (page_desc_node *pdn = default_page_manager->page_all; pdn != NULL; pdn = pdn->next)
+        live_cnt++;
+
+    bool anim_done = is_page_anim_done();
+    uint32_t depth = 0;
+    for (page_base_node *pbn = default_page_manager->page_stack; pbn != NULL; pbn = pbn->next) {
+        page_base *page = &pbn->base;
+        live_cnt++;
+        if (page->node != pbn || !find_page_desc_in_pool(page->desc)) {
+            p_error("%s: page node or desc broken at depth %u", __FUNCTION__, (unsigned)depth);
+            return false;
+        }
+        if (depth >= 2 && page->is_anim_busy) {
+            p_error("%s: page %s is covered but animating", __FUNCTION__, page->desc->page_name);
+            return false;
+        }
+        if (page->lv_root == NULL) {
+            // restore记录但尚未创建的页面
+            if (depth == 0 || page->state != PAGE_STATE_IDLE || page->vlist != NULL) {
+                p_error("%s: page %s is not built in state %d", __FUNCTION__, page->desc->page_name,
+                        page->state);
+                return false;
+            }
+            if (page->saved_state != NULL)
+                live_cnt++;
+        } else {
+            if (page->saved_state != NULL) {
+                p_error("%s: page %s state is not released", __FUNCTION__, page->desc->page_name);
+                return false;
+            }
+            if (anim_done) {
+                page_state expect = depth == 0 ? PAGE_STATE_ACTIVITY : PAGE_STATE_WILL_APPEAR;
+                if (page->state != expect || lv_obj_has_flag(page->lv_root, LV_OBJ_FLAG_HIDDEN) == (depth == 0)) {
+                    p_error("%s: page %s in state %d at depth %u", __FUNCTION__, page->desc->page_name,
+                            page->state, (unsigned)depth);
+                    return false;
+                }
+            }
+        }
+        for (page_vlist *vl = page->vlist; vl != NULL; vl = vl->next) {
+            if (vl->page != page) {
+                p_error("%s: page %s vlist owner broken", __FUNCTION__, page->desc->page_name);
+                return false;
+            }
+            live_cnt += page_vlist_alloc_cnt(vl);
+        }
+        depth++;
+    }
+
+    if (page_out != NULL) {
+        live_cnt++;
+        for (page_vlist *vl = page_out->base.vlist; vl != NULL; vl = vl->next)
+            live_cnt += page_vlist_alloc_cnt(vl);
+    }
+
+    uint32_t alloc_cnt = page_alloc_cnt - page_free_cnt;
+    if (alloc_cnt != live_cnt) {
+        p_error("%s: %u allocations alive, %u expected", __FUNCTION__,
+                (unsigned)alloc_cnt, (unsigned)live_cnt);
+        return false;
+    }
+    return true;
+}
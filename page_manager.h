@@ -15,6 +15,29 @@ typedef struct page_base_node_t {
     struct page_base_node_t *next;
 } page_base_node;
 
+typedef struct page_vlist_t {
+    lv_obj_t *cont;                     /* 滚动容器 */
+    lv_obj_t **rows;                    /* 行对象池 */
+    uint32_t *row_index;                /* 行对象当前绑定的行号 */
+    uint32_t pool_cnt;                  /* 行对象池大小 */
+    uint32_t row_cnt;                   /* 总行数 */
+    lv_coord_t row_h;                   /* 行高 */
+    page_vlist_create_row_t create_row; /* 创建行对象 */
+    page_vlist_bind_t bind;             /* 绑定行数据 */
+    page_base *page;                    /* 所属页面 */
+    struct page_vlist_t *next;
+} page_vlist;
+
+typedef struct page_manager_stats_t {
+    uint32_t alloc_cnt;   /* 页面管理器分配次数 */
+    uint32_t free_cnt;    /* 页面管理器释放次数 */
+    uint32_t pool_cnt;    /* 已注册页面数 */
+    uint32_t stack_depth; /* 页面栈深度 */
+    uint32_t gc_pending;  /* 等待删除的页面数 */
+    uint32_t lv_mem_used; /* lv_mem已使用字节 */
+    uint8_t lv_mem_frag;  /* lv_mem碎片率 */
+} page_manager_stats;
+
 typedef struct page_manager_t {
     page_desc_node *page_all;
     page_base_node *page_stack;
@@ -24,9 +47,16 @@ bool page_manager_init(void);
 bool page_desc_init(page_desc *page, create_page_t cb, const char *name);
 bool page_uninstall(page_desc *);
 
+// debug function
+void page_manager_get_stats(page_manager_stats *);
+bool page_manager_check(void);
+
 // route function
 page_base *page_push(page_desc *);
 page_base *page_pop(void);
+uint32_t page_stack_save(uint8_t *buf, uint32_t size);
+bool page_stack_restore(const uint8_t *buf, uint32_t size);
+page_base *page_find_by_obj(const lv_obj_t *);
 
 // state function
 void page_state_run(page_base *);
@@ -38,4 +68,14 @@ void page_set_disappear_anim(page_base *, page_anim_attr *);
 void page_anim_appear_start(void);
 void page_anim_disappear_start(void);
 
+// page virtual list function
+page_vlist *page_vlist_create(lv_obj_t *parent, uint32_t row_cnt, lv_coord_t row_h,
+                              page_vlist_create_row_t create_row, page_vlist_bind_t bind);
+void page_vlist_set_row_cnt(page_vlist *, uint32_t);
+void page_vlist_refresh(page_vlist *);
+
+// page teardown function
+void page_gc_flush(void);
+uint32_t page_gc_pending(void);
+
 #endif /* __PAGE_MANAGER_H__ */
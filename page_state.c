@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "page_log.h"
+#include "page_internal.h"
 #include "src/misc/lv_mem.h"
 #include "src/misc/lv_style.h"
 
@@ -17,6 +18,9 @@ static page_state do_will_disappear(page_base *);
 static page_state do_did_disappear(page_base *);
 static page_state do_unload(page_base *);
 
+// restore时直接显示栈顶页面
+static page_anim_attr restore_anim = {PAGE_ANIM_NONE, PAGE_ANIM_LINEAR, 0};
+
 void page_state_run(page_base *page)
 {
     if (page == NULL)
@@ -50,7 +54,8 @@ void page_state_run(page_base *page)
             page_state_run(page);
         break;
     case PAGE_STATE_UNLOAD:
-        page->state = do_unload(page);
+        // page is freed in do_unload(), do not write state back
+        do_unload(page);
         break;
     }
 }
@@ -59,10 +64,20 @@ void page_state_run(page_base *page)
 static page_state do_load(page_base *page)
 {
     p_log("page %s: will load", page->desc->page_name);
+    // 内存不足时先删除等待回收的页面
+    if (page_gc_is_mem_low())
+        page_gc_flush();
     if (page->desc->on_will_load != NULL)
         page->desc->on_will_load(NULL);
     page->lv_root = lv_obj_create(lv_scr_act());
     page->desc->create_page(page->lv_root);
+    if (page->saved_state != NULL) {
+        if (page->desc->restore_state != NULL)
+            page->desc->restore_state(page->lv_root, page->saved_state, page->saved_size);
+        page_free(page->saved_state);
+        page->saved_state = NULL;
+        page->saved_size = 0;
+    }
     p_log("page %s: loaded", page->desc->page_name);
     if (page->desc->on_loaded != NULL)
         page->desc->on_loaded(page->lv_root);
@@ -73,12 +88,16 @@ static page_state do_load(page_base *page)
 static page_state do_will_appear(page_base *page)
 {
     p_log("page %s: will appear", page->desc->page_name);
+    page_vlist_restore(page);
     if (page->desc->on_will_appear != NULL)
         page->desc->on_will_appear(page->lv_root);
     lv_obj_clear_flag(page->lv_root, LV_OBJ_FLAG_HIDDEN);
 
     // animation init
-    if (page->is_push)
+    if (page->is_restore) {
+        page->is_restore = false;
+        page_set_appear_anim(page, &restore_anim);
+    } else if (page->is_push)
         page_set_appear_anim(page, &page->desc->anim_desc.page_push_in);
     else
         page_set_appear_anim(page, &page->desc->anim_desc.page_pop_in);
@@ -126,14 +145,17 @@ static page_state do_did_disappear(page_base *page)
     if (page->desc->on_disappeared != NULL)
         page->desc->on_disappeared(page->lv_root);
     page->is_anim_busy = false;
-    if (page->is_push == true)
+    if (page->is_push == true) {
+        // 被覆盖的页面释放虚拟列表的行对象
+        page_vlist_release(page);
         return PAGE_STATE_WILL_APPEAR;
+    }
     else
         return PAGE_STATE_UNLOAD;
 }
 
 // free styles mem
-static void free_page_styles(const lv_obj_t *obj)
+void free_page_styles(const lv_obj_t *obj)
 {
     if (obj == NULL)
         return;
@@ -149,19 +171,22 @@ static void free_page_styles(const lv_obj_t *obj)
         free_page_styles(lv_obj_get_child(obj, i));
 }
 
-// del lv_obj
+// detach lv_obj, it is deleted by page_gc when ui is idle
+// on_unloaded runs before lv_obj is deleted, LV_EVENT_DELETE handlers run later
 static page_state do_unload(page_base *page)
 {
     p_log("page %s: will unload", page->desc->page_name);
     if (page->desc->on_will_unload != NULL)
         page->desc->on_will_unload(page->lv_root);
-    // need to reset all style int root&root's children
-    free_page_styles(page->lv_root);
-    lv_obj_del(page->lv_root);
+    page_vlist_free(page);
+    // styles are reset and lv_obj deleted in page_gc
+    page_gc_add(page->lv_root, page->desc);
+    page->lv_root = NULL;
     p_log("page %s: unloaded", page->desc->page_name);
     if (page->desc->on_unloaded != NULL)
         page->desc->on_unloaded(NULL);
+    page_pop_done(page);
     // free node in page stack
-    free(page->node);
+    page_free(page->node);
     return PAGE_STATE_IDLE;
 }
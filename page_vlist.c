@@ -0,0 +1,273 @@
+#include "page_base.h"
+#include "page_manager.h"
+#include "page_log.h"
+#include "page_internal.h"
+#include "src/core/lv_event.h"
+#include "src/core/lv_obj.h"
+#include "src/core/lv_obj_pos.h"
+#include "src/core/lv_obj_scroll.h"
+#include "src/core/lv_obj_tree.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// 可见区域上下各多保留的行数
+#define PAGE_VLIST_MARGIN 2
+
+// 滚动范围，内容总高度超过LV_COORD_MAX时截断
+static lv_coord_t vlist_extent(page_vlist *vl)
+{
+    uint64_t total = (uint64_t)vl->row_cnt * vl->row_h;
+    return total > LV_COORD_MAX ? LV_COORD_MAX : (lv_coord_t)total;
+}
+
+// 把滚动位置映射到内容偏移，滚动范围被截断时按比例映射
+static uint64_t vlist_offset(page_vlist *vl)
+{
+    lv_coord_t scroll_y = lv_obj_get_scroll_y(vl->cont);
+    if (scroll_y <= 0)
+        return 0;
+    uint64_t total = (uint64_t)vl->row_cnt * vl->row_h;
+    lv_coord_t extent = vlist_extent(vl);
+    lv_coord_t view = lv_obj_get_content_height(vl->cont);
+    if (total == (uint64_t)extent || extent <= view || total <= (uint64_t)view)
+        return scroll_y;
+    uint64_t offset = (uint64_t)scroll_y * (total - view) / (extent - view);
+    return offset > total - view ? total - view : offset;
+}
+
+// 将可见区域附近的行绑定到行对象，行号i固定使用第i % pool_cnt个行对象
+// 行对象是floating的，不随容器滚动，位置相对可见区域计算，不会超出lv_coord_t
+static void vlist_update(page_vlist *vl, bool force)
+{
+    if (vl->rows == NULL)
+        return;
+    uint64_t offset = vlist_offset(vl);
+    uint32_t first = offset / vl->row_h;
+    first = first > PAGE_VLIST_MARGIN ? first - PAGE_VLIST_MARGIN : 0;
+    if (first + vl->pool_cnt > vl->row_cnt)
+        first = vl->row_cnt - vl->pool_cnt;
+
+    for (uint32_t i = first; i < first + vl->pool_cnt; i++) {
+        uint32_t slot = i % vl->pool_cnt;
+        lv_obj_set_y(vl->rows[slot], (lv_coord_t)((int64_t)i * vl->row_h - (int64_t)offset));
+        if (!force && vl->row_index[slot] == i)
+            continue;
+        vl->row_index[slot] = i;
+        vl->bind(vl->rows[slot], i);
+    }
+}
+
+// 创建行对象池，大小为可见行数加上下余量
+static void vlist_materialize(page_vlist *vl)
+{
+    if (vl->rows != NULL || vl->row_cnt == 0)
+        return;
+    uint32_t pool_cnt = lv_obj_get_content_height(vl->cont) / vl->row_h + 1 + 2 * PAGE_VLIST_MARGIN;
+    if (pool_cnt > vl->row_cnt)
+        pool_cnt = vl->row_cnt;
+
+    // free in vlist_dematerialize()
+    vl->rows = page_calloc(pool_cnt, sizeof(lv_obj_t *));
+    vl->row_index = page_calloc(pool_cnt, sizeof(uint32_t));
+    if (vl->rows == NULL || vl->row_index == NULL) {
+        p_error("page_vlist rows calloc failed");
+        page_free(vl->rows);
+        page_free(vl->row_index);
+        vl->rows = NULL;
+        vl->row_index = NULL;
+        return;
+    }
+    vl->pool_cnt = pool_cnt;
+    for (uint32_t i = 0; i < pool_cnt; i++) {
+        vl->rows[i] = lv_obj_create(vl->cont);
+        lv_obj_set_size(vl->rows[i], lv_pct(100), vl->row_h);
+        lv_obj_add_flag(vl->rows[i], LV_OBJ_FLAG_FLOATING);
+        if (vl->create_row != NULL)
+            vl->create_row(vl->rows[i]);
+    }
+    vlist_update(vl, true);
+}
+
+// 删除行对象池
+static void vlist_dematerialize(page_vlist *vl)
+{
+    if (vl->rows == NULL)
+        return;
+    for (uint32_t i = 0; i < vl->pool_cnt; i++) {
+        free_page_styles(vl->rows[i]);
+        lv_obj_del(vl->rows[i]);
+    }
+    page_free(vl->rows);
+    page_free(vl->row_index);
+    vl->rows = NULL;
+    vl->row_index = NULL;
+    vl->pool_cnt = 0;
+}
+
+static void vlist_event_cb(lv_event_t *e)
+{
+    page_vlist *vl = lv_event_get_user_data(e);
+
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_SCROLL:
+        vlist_update(vl, false);
+        break;
+    case LV_EVENT_SIZE_CHANGED:
+        // 可见行数可能变化，重新创建行对象池
+        if (vl->rows != NULL) {
+            vlist_dematerialize(vl);
+            vlist_materialize(vl);
+        }
+        break;
+    case LV_EVENT_GET_SELF_SIZE: {
+        // 滚动范围由总行数决定，而不是已创建的行对象
+        lv_point_t *p = lv_event_get_param(e);
+        p->y = LV_MAX(p->y, vlist_extent(vl));
+        break;
+    }
+    case LV_EVENT_DELETE:
+        // 行对象由lvgl随容器一起删除，这里只释放记录
+        for (page_vlist **pvl = &vl->page->vlist; *pvl != NULL; pvl = &(*pvl)->next) {
+            if (*pvl == vl) {
+                *pvl = vl->next;
+                break;
+            }
+        }
+        page_free(vl->rows);
+        page_free(vl->row_index);
+        page_free(vl);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Create a virtual list, only rows near the visible area are created
+ *
+ * The list is bound to the page which parent belongs to: row objects are
+ * released when the page is covered and created again when it appears.
+ * When row_cnt * row_h exceeds LV_COORD_MAX the scroll range is capped
+ * and scroll position is mapped to rows proportionally.
+ * @param parent Parent lv_obj, usually page root or its child
+ * @param row_cnt Number of rows
+ * @param row_h Height of each row
+ * @param create_row Called once for each row object, can be NULL
+ * @param bind Called to fill row object with data of row index
+ * @return page_vlist* Pointer to virtual list, freed with its container
+ */
+page_vlist *page_vlist_create(lv_obj_t *parent, uint32_t row_cnt, lv_coord_t row_h,
+                              page_vlist_create_row_t create_row, page_vlist_bind_t bind)
+{
+    if (parent == NULL || row_h <= 0 || bind == NULL) {
+        p_warning("%s: param error", __FUNCTION__);
+        return NULL;
+    }
+    page_base *page = page_find_by_obj(parent);
+    if (page == NULL) {
+        p_warning("%s: parent is not in any page", __FUNCTION__);
+        return NULL;
+    }
+
+    // free in vlist_event_cb() LV_EVENT_DELETE
+    page_vlist *vl = page_calloc(1, sizeof(page_vlist));
+    if (vl == NULL) {
+        p_error("page_vlist calloc failed");
+        return NULL;
+    }
+    vl->row_cnt = row_cnt;
+    vl->row_h = row_h;
+    vl->create_row = create_row;
+    vl->bind = bind;
+    vl->page = page;
+    vl->next = page->vlist;
+    page->vlist = vl;
+
+    vl->cont = lv_obj_create(parent);
+    lv_obj_set_size(vl->cont, lv_pct(100), lv_pct(100));
+    lv_obj_set_scroll_dir(vl->cont, LV_DIR_VER);
+    lv_obj_add_event_cb(vl->cont, vlist_event_cb, LV_EVENT_ALL, vl);
+    lv_obj_refresh_self_size(vl->cont);
+    lv_obj_update_layout(vl->cont);
+    vlist_materialize(vl);
+    return vl;
+}
+
+/**
+ * @brief Change number of rows and rebind row objects
+ * @param vl Pointer to virtual list
+ * @param row_cnt Number of rows
+ */
+void page_vlist_set_row_cnt(page_vlist *vl, uint32_t row_cnt)
+{
+    if (vl == NULL)
+        return;
+    vl->row_cnt = row_cnt;
+    lv_obj_refresh_self_size(vl->cont);
+    vlist_dematerialize(vl);
+    // 页面被覆盖时只记录行数，显示时再创建
+    if (!lv_obj_has_flag(vl->page->lv_root, LV_OBJ_FLAG_HIDDEN))
+        vlist_materialize(vl);
+}
+
+/**
+ * @brief Rebind all row objects, used after row data changed
+ * @param vl Pointer to virtual list
+ */
+void page_vlist_refresh(page_vlist *vl)
+{
+    if (vl == NULL)
+        return;
+    vlist_update(vl, true);
+}
+
+/**
+ * @brief Release row objects of all virtual lists in page
+ * @param page Pointer to page
+ */
+void page_vlist_release(page_base *page)
+{
+    for (page_vlist *vl = page->vlist; vl != NULL; vl = vl->next)
+        vlist_dematerialize(vl);
+}
+
+/**
+ * @brief Create row objects of all virtual lists in page
+ * @param page Pointer to page
+ */
+void page_vlist_restore(page_base *page)
+{
+    for (page_vlist *vl = page->vlist; vl != NULL; vl = vl->next)
+        vlist_materialize(vl);
+}
+
+/**
+ * @brief Free all virtual lists in page when page is unloaded
+ *
+ * Row objects are left in page tree and deleted with it.
+ * @param page Pointer to page
+ */
+void page_vlist_free(page_base *page)
+{
+    page_vlist *vl = page->vlist;
+    while (vl != NULL) {
+        page_vlist *next = vl->next;
+        lv_obj_remove_event_cb(vl->cont, vlist_event_cb);
+        page_free(vl->rows);
+        page_free(vl->row_index);
+        page_free(vl);
+        vl = next;
+    }
+    page->vlist = NULL;
+}
+
+/**
+ * @brief Number of page_calloc() allocations owned by virtual list
+ * @param vl Pointer to virtual list
+ * @return uint32_t list record, plus row pool and row index when rows exist
+ */
+uint32_t page_vlist_alloc_cnt(const page_vlist *vl)
+{
+    return vl->rows != NULL ? 3 : 1;
+}
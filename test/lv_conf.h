@@ -0,0 +1,12 @@
+/* lvgl config for the headless soak test, unset options use lvgl defaults */
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+#define LV_COLOR_DEPTH 16
+#define LV_MEM_CUSTOM 0
+#define LV_MEM_SIZE (128U * 1024U)
+#define LV_TICK_CUSTOM 0
+#define LV_USE_LOG 0
+#define LV_USE_USER_DATA 1
+
+#endif /* LV_CONF_H */
@@ -0,0 +1,634 @@
+/*
+ * Navigation soak test: random push/pop/replace/uninstall/restore sequences
+ * on a headless lvgl display with a fake tick.
+ *
+ * After every step the page stack is checked with page_manager_check() and
+ * every lifecycle callback is checked against a per-page state machine.
+ * Every SOAK_SAMPLE_STEPS steps the stack is emptied and page manager
+ * allocations, lv_mem and libc heap usage are sampled; any growth over the
+ * baseline taken after warm up fails the test.
+ *
+ * usage: soak [steps] [seed]
+ */
+#include "lvgl.h"
+#include "page_base.h"
+#include "page_manager.h"
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SOAK_PAGE_CNT 6
+#define SOAK_VLIST_PAGE 1     /* 带虚拟列表的页面 */
+#define SOAK_TREE_PAGE 2      /* 大量子节点的页面 */
+#define SOAK_TICK 5           /* 每次推进的ms */
+#define SOAK_SETTLE_MAX 2000  /* 等待动画结束的最大tick数 */
+#define SOAK_SAMPLE_STEPS 10000
+#define SOAK_WARMUP_SAMPLES 2 /* 之后的采样作为基准 */
+#define SOAK_MAX_FRAG 50      /* lv_mem碎片率上限 */
+#define SOAK_EVENT_LOG 32     /* 失败时打印的最近回调数 */
+
+typedef enum {
+    EV_WILL_LOAD,
+    EV_LOADED,
+    EV_WILL_APPEAR,
+    EV_APPEARED,
+    EV_WILL_DISAPPEAR,
+    EV_DISAPPEARED,
+    EV_WILL_UNLOAD,
+    EV_UNLOADED,
+} soak_event;
+
+typedef enum {
+    ST_UNLOADED,
+    ST_LOADING,
+    ST_LOADED,
+    ST_APPEARING,
+    ST_SHOWN,
+    ST_DISAPPEARING,
+    ST_HIDDEN,
+    ST_UNLOADING,
+} soak_state;
+
+static const char *event_name[] = {
+    "will_load", "loaded",      "will_appear", "appeared",
+    "will_disappear", "disappeared", "will_unload", "unloaded",
+};
+
+typedef struct soak_page_t {
+    page_desc desc;
+    char name[16];
+    soak_state state;   /* 按回调顺序推出的页面状态 */
+    const lv_obj_t *root;
+} soak_page;
+
+static soak_page pages[SOAK_PAGE_CNT];
+static int stack[SOAK_PAGE_CNT]; /* 页面栈模型，从栈底到栈顶 */
+static int depth = 0;
+static int loading = -1;         /* 正在创建的页面 */
+static page_vlist *vlist = NULL; /* 在on_unloaded中清空 */
+
+static uint32_t seed;
+static uint32_t rnd_state;
+static uint32_t step = 0;
+static const char *op_name = "init";
+
+static struct {
+    uint32_t step;
+    int page;
+    soak_event ev;
+} event_log[SOAK_EVENT_LOG];
+static uint32_t event_cnt = 0;
+
+static void fail(const char *fmt, ...)
+{
+    va_list args;
+    printf("[soak] FAIL seed %u step %u op %s: ", (unsigned)seed, (unsigned)step, op_name);
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    printf("\n[soak] last callbacks:\n");
+    uint32_t first = event_cnt > SOAK_EVENT_LOG ? event_cnt - SOAK_EVENT_LOG : 0;
+    for (uint32_t i = first; i < event_cnt; i++) {
+        int n = i % SOAK_EVENT_LOG;
+        printf("  step %u page%d %s\n", (unsigned)event_log[n].step, event_log[n].page,
+               event_name[event_log[n].ev]);
+    }
+    exit(1);
+}
+
+static uint32_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/*
+ * lifecycle order recorder
+ */
+
+static void on_event(int idx, soak_event ev, const lv_obj_t *obj)
+{
+    soak_page *p = &pages[idx];
+    int n = event_cnt++ % SOAK_EVENT_LOG;
+    event_log[n].step = step;
+    event_log[n].page = idx;
+    event_log[n].ev = ev;
+
+    bool ok = false;
+    soak_state next = p->state;
+    switch (ev) {
+    case EV_WILL_LOAD:
+        ok = p->state == ST_UNLOADED && obj == NULL;
+        next = ST_LOADING;
+        loading = idx;
+        break;
+    case EV_LOADED:
+        ok = p->state == ST_LOADING && obj != NULL;
+        next = ST_LOADED;
+        p->root = obj;
+        loading = -1;
+        break;
+    case EV_WILL_APPEAR:
+        ok = p->state == ST_LOADED || p->state == ST_HIDDEN;
+        next = ST_APPEARING;
+        break;
+    case EV_APPEARED:
+        ok = p->state == ST_APPEARING;
+        next = ST_SHOWN;
+        break;
+    case EV_WILL_DISAPPEAR:
+        ok = p->state == ST_SHOWN;
+        next = ST_DISAPPEARING;
+        break;
+    case EV_DISAPPEARED:
+        ok = p->state == ST_DISAPPEARING;
+        next = ST_HIDDEN;
+        break;
+    case EV_WILL_UNLOAD:
+        ok = p->state == ST_HIDDEN;
+        next = ST_UNLOADING;
+        break;
+    case EV_UNLOADED:
+        ok = p->state == ST_UNLOADING && obj == NULL;
+        next = ST_UNLOADED;
+        p->root = NULL;
+        if (idx == SOAK_VLIST_PAGE)
+            vlist = NULL;
+        break;
+    }
+    if (!ok)
+        fail("page%d %s in state %d", idx, event_name[ev], p->state);
+    if (ev != EV_WILL_LOAD && ev != EV_LOADED && ev != EV_UNLOADED && obj != p->root)
+        fail("page%d %s with wrong root", idx, event_name[ev]);
+    p->state = next;
+}
+
+/*
+ * page content
+ */
+
+static void vlist_create_row(lv_obj_t *row)
+{
+    lv_label_create(row);
+}
+
+static void vlist_bind(lv_obj_t *row, uint32_t index)
+{
+    lv_label_set_text_fmt(lv_obj_get_child(row, 0), "row %u", (unsigned)index);
+}
+
+static void create_page(int idx, lv_obj_t *root)
+{
+    lv_obj_set_size(root, LCD_V, LCD_H);
+    lv_obj_t *label = lv_label_create(root);
+    lv_label_set_text_fmt(label, "page%d", idx);
+
+    // style freed by free_page_styles() through user_data
+    lv_style_t *style = malloc(sizeof(lv_style_t));
+    lv_style_init(style);
+    lv_style_set_bg_color(style, lv_color_hex(0x336699));
+    lv_obj_t *obj = lv_obj_create(root);
+    lv_obj_add_style(obj, style, 0);
+    lv_obj_set_user_data(obj, style);
+
+    if (idx == SOAK_VLIST_PAGE) {
+        vlist = page_vlist_create(root, 3000, 30, vlist_create_row, vlist_bind);
+        if (vlist == NULL)
+            fail("page_vlist_create failed");
+    } else if (idx == SOAK_TREE_PAGE) {
+        lv_obj_t *cont = lv_obj_create(root);
+        lv_obj_set_size(cont, lv_pct(100), lv_pct(100));
+        lv_obj_set_flex_flow(cont, LV_FLEX_FLOW_ROW_WRAP);
+        for (int i = 0; i < 100; i++) {
+            lv_obj_t *item = lv_obj_create(cont);
+            lv_label_set_text_fmt(lv_label_create(item), "%d", i);
+        }
+    }
+}
+
+static uint32_t save_state(const lv_obj_t *root, void *buf, uint32_t size)
+{
+    for (int i = 0; i < SOAK_PAGE_CNT; i++) {
+        if (pages[i].root == root && size >= 1) {
+            *(uint8_t *)buf = i;
+            return 1;
+        }
+    }
+    fail("save_state of unknown page");
+    return 0;
+}
+
+static void restore_state(lv_obj_t *root, const void *buf, uint32_t size)
+{
+    if (size != 1 || *(const uint8_t *)buf != loading)
+        fail("page%d restored with state of another page", loading);
+}
+
+#define SOAK_PAGE_CALLBACKS(i)                                                                     \
+    static void page##i##_create(lv_obj_t *o) { create_page(i, o); }                               \
+    static void page##i##_will_load(const lv_obj_t *o) { on_event(i, EV_WILL_LOAD, o); }           \
+    static void page##i##_loaded(const lv_obj_t *o) { on_event(i, EV_LOADED, o); }                 \
+    static void page##i##_will_appear(const lv_obj_t *o) { on_event(i, EV_WILL_APPEAR, o); }       \
+    static void page##i##_appeared(const lv_obj_t *o) { on_event(i, EV_APPEARED, o); }             \
+    static void page##i##_will_disappear(const lv_obj_t *o) { on_event(i, EV_WILL_DISAPPEAR, o); } \
+    static void page##i##_disappeared(const lv_obj_t *o) { on_event(i, EV_DISAPPEARED, o); }       \
+    static void page##i##_will_unload(const lv_obj_t *o) { on_event(i, EV_WILL_UNLOAD, o); }       \
+    static void page##i##_unloaded(const lv_obj_t *o) { on_event(i, EV_UNLOADED, o); }
+
+#define SOAK_PAGE_BIND(i)                                          \
+    do {                                                           \
+        pages[i].desc.on_will_load = page##i##_will_load;          \
+        pages[i].desc.on_loaded = page##i##_loaded;                \
+        pages[i].desc.on_will_appear = page##i##_will_appear;      \
+        pages[i].desc.on_appeared = page##i##_appeared;            \
+        pages[i].desc.on_will_disappear = page##i##_will_disappear; \
+        pages[i].desc.on_disappeared = page##i##_disappeared;      \
+        pages[i].desc.on_will_unload = page##i##_will_unload;      \
+        pages[i].desc.on_unloaded = page##i##_unloaded;            \
+        page_create[i] = page##i##_create;                         \
+    } while (0)
+
+SOAK_PAGE_CALLBACKS(0)
+SOAK_PAGE_CALLBACKS(1)
+SOAK_PAGE_CALLBACKS(2)
+SOAK_PAGE_CALLBACKS(3)
+SOAK_PAGE_CALLBACKS(4)
+SOAK_PAGE_CALLBACKS(5)
+
+static create_page_t page_create[SOAK_PAGE_CNT];
+
+static void random_anim(page_anim_attr *attr)
+{
+    static const uint32_t duration[] = {0, 20, 60, 150};
+    attr->anim_type = rnd() % (PAGE_FADE + 1);
+    attr->anim_curve = rnd() % (PAGE_ANIM_BOUNCE + 1);
+    attr->duration = duration[rnd() % 4];
+}
+
+static void install_page(int idx)
+{
+    page_anim_desc *anim = &pages[idx].desc.anim_desc;
+    random_anim(&anim->page_push_in);
+    random_anim(&anim->page_push_out);
+    random_anim(&anim->page_pop_in);
+    random_anim(&anim->page_pop_out);
+    if (!page_desc_init(&pages[idx].desc, page_create[idx], pages[idx].name))
+        fail("page%d install failed", idx);
+}
+
+/*
+ * headless lvgl driver
+ */
+
+static void disp_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    lv_disp_flush_ready(drv);
+}
+
+static void disp_init(void)
+{
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[LCD_V * 20];
+    static lv_disp_drv_t drv;
+
+    lv_disp_draw_buf_init(&draw_buf, buf, NULL, LCD_V * 20);
+    lv_disp_drv_init(&drv);
+    drv.hor_res = LCD_V;
+    drv.ver_res = LCD_H;
+    drv.flush_cb = disp_flush;
+    drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&drv);
+}
+
+static void advance(uint32_t ticks)
+{
+    for (uint32_t i = 0; i < ticks; i++) {
+        lv_tick_inc(SOAK_TICK);
+        lv_timer_handler();
+    }
+}
+
+// 运行到所有页面动画结束
+static void settle(void)
+{
+    uint32_t ticks = 0;
+    while (lv_anim_count_running() != 0) {
+        if (ticks++ > SOAK_SETTLE_MAX)
+            fail("page animation never finished");
+        advance(1);
+    }
+}
+
+/*
+ * model checks
+ */
+
+static uint32_t stack_depth(void)
+{
+    page_manager_stats stats;
+    page_manager_get_stats(&stats);
+    return stats.stack_depth;
+}
+
+static bool in_stack(int idx)
+{
+    for (int i = 0; i < depth; i++)
+        if (stack[i] == idx)
+            return true;
+    return false;
+}
+
+static int pick_page_not_in_stack(void)
+{
+    if (depth == SOAK_PAGE_CNT)
+        return -1;
+    int idx = rnd() % SOAK_PAGE_CNT;
+    while (in_stack(idx))
+        idx = (idx + 1) % SOAK_PAGE_CNT;
+    return idx;
+}
+
+static void check_settled(void)
+{
+    if (stack_depth() != (uint32_t)depth)
+        fail("stack depth %u, model %d", (unsigned)stack_depth(), depth);
+    for (int i = 0; i < SOAK_PAGE_CNT; i++) {
+        soak_state s = pages[i].state;
+        bool ok;
+        if (depth > 0 && stack[depth - 1] == i)
+            ok = s == ST_SHOWN;
+        else if (in_stack(i))
+            ok = s == ST_HIDDEN || s == ST_UNLOADED;
+        else
+            ok = s == ST_UNLOADED;
+        if (!ok)
+            fail("page%d in state %d after animations finished", i, s);
+    }
+}
+
+/*
+ * operations
+ */
+
+static void op_push(void)
+{
+    op_name = "push";
+    int idx = pick_page_not_in_stack();
+    if (idx < 0)
+        return;
+    // 动画执行中会被拒绝
+    if (page_push(&pages[idx].desc) != NULL)
+        stack[depth++] = idx;
+}
+
+static void do_pop(void)
+{
+    uint32_t before = stack_depth();
+    page_pop();
+    if (stack_depth() + 1 == before)
+        depth--;
+    else if (stack_depth() != before)
+        fail("page_pop changed depth %u -> %u", (unsigned)before, (unsigned)stack_depth());
+}
+
+static void op_pop(void)
+{
+    op_name = "pop";
+    if (depth > 0)
+        do_pop();
+}
+
+static void pop_all(void)
+{
+    while (depth > 0) {
+        settle();
+        int before = depth;
+        do_pop();
+        if (depth == before)
+            fail("page_pop rejected after animations finished");
+    }
+    settle();
+}
+
+static void op_replace(void)
+{
+    op_name = "replace";
+    settle();
+    if (depth > 0) {
+        do_pop();
+        settle();
+    }
+    // 可能重新创建刚出栈、尚未删除的页面
+    int idx = pick_page_not_in_stack();
+    if (page_push(&pages[idx].desc) == NULL)
+        fail("page%d push rejected after animations finished", idx);
+    stack[depth++] = idx;
+    settle();
+    check_settled();
+}
+
+static void op_uninstall(void)
+{
+    op_name = "uninstall";
+    settle();
+    int idx = rnd() % SOAK_PAGE_CNT;
+    if (in_stack(idx)) {
+        if (page_uninstall(&pages[idx].desc))
+            fail("page%d uninstalled while in stack", idx);
+        return;
+    }
+    if (!page_uninstall(&pages[idx].desc))
+        fail("page%d uninstall failed", idx);
+    install_page(idx);
+}
+
+static void op_scroll(void)
+{
+    op_name = "scroll";
+    if (vlist != NULL)
+        lv_obj_scroll_to_y(vlist->cont, rnd() % LV_COORD_MAX, LV_ANIM_OFF);
+}
+
+static void op_restore(void)
+{
+    op_name = "restore";
+    settle();
+    uint8_t buf[64];
+    uint32_t size = page_stack_save(buf, sizeof(buf));
+    if (size == 0)
+        fail("page_stack_save failed");
+    int saved[SOAK_PAGE_CNT];
+    int saved_depth = depth;
+    memcpy(saved, stack, sizeof(stack));
+    pop_all();
+    if (!page_stack_restore(buf, size))
+        fail("page_stack_restore failed");
+    memcpy(stack, saved, sizeof(stack));
+    depth = saved_depth;
+    settle();
+    check_settled();
+}
+
+/*
+ * memory tracking
+ */
+
+/*
+ * libc heap used by page manager, pages and lvgl, linked with -Wl,--wrap.
+ * Requested size is kept in a header, malloc_usable_size() varies with
+ * chunk splitting.
+ */
+#define SOAK_MEM_HDR 16
+static size_t libc_used = 0;
+
+void *__real_malloc(size_t size);
+void *__real_realloc(void *p, size_t size);
+void __real_free(void *p);
+
+void *__wrap_malloc(size_t size)
+{
+    uint8_t *p = __real_malloc(size + SOAK_MEM_HDR);
+    if (p == NULL)
+        return NULL;
+    *(size_t *)p = size;
+    libc_used += size;
+    return p + SOAK_MEM_HDR;
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    if (size != 0 && n > (SIZE_MAX - SOAK_MEM_HDR) / size)
+        return NULL;
+    void *p = __wrap_malloc(n * size);
+    if (p != NULL)
+        memset(p, 0, n * size);
+    return p;
+}
+
+void __wrap_free(void *p)
+{
+    if (p == NULL)
+        return;
+    uint8_t *hdr = (uint8_t *)p - SOAK_MEM_HDR;
+    libc_used -= *(size_t *)hdr;
+    __real_free(hdr);
+}
+
+void *__wrap_realloc(void *p, size_t size)
+{
+    if (p == NULL)
+        return __wrap_malloc(size);
+    if (size == 0) {
+        __wrap_free(p);
+        return NULL;
+    }
+    uint8_t *hdr = (uint8_t *)p - SOAK_MEM_HDR;
+    size_t old = *(size_t *)hdr;
+    hdr = __real_realloc(hdr, size + SOAK_MEM_HDR);
+    if (hdr == NULL)
+        return NULL;
+    *(size_t *)hdr = size;
+    libc_used = libc_used - old + size;
+    return hdr + SOAK_MEM_HDR;
+}
+
+typedef struct soak_sample_t {
+    uint32_t lv_mem_used;
+    uint32_t libc_used;
+    uint8_t lv_mem_frag;
+} soak_sample;
+
+static void sample(uint32_t index, soak_sample *base)
+{
+    op_name = "sample";
+    pop_all();
+    page_gc_flush();
+    advance(1);
+    check_settled();
+
+    page_manager_stats stats;
+    page_manager_get_stats(&stats);
+    printf("[soak] step %u: live %u gc %u lv_mem %u frag %u%% libc %u\n", (unsigned)step,
+           (unsigned)(stats.alloc_cnt - stats.free_cnt), (unsigned)stats.gc_pending,
+           (unsigned)stats.lv_mem_used, (unsigned)stats.lv_mem_frag, (unsigned)libc_used);
+
+    // 栈为空时只剩页面池节点
+    if (stats.alloc_cnt - stats.free_cnt != stats.pool_cnt || stats.gc_pending != 0)
+        fail("%u page allocations alive with empty stack",
+             (unsigned)(stats.alloc_cnt - stats.free_cnt));
+    if (stats.lv_mem_frag > SOAK_MAX_FRAG)
+        fail("lv_mem fragmentation %u%%", (unsigned)stats.lv_mem_frag);
+    if (index == SOAK_WARMUP_SAMPLES) {
+        base->lv_mem_used = stats.lv_mem_used;
+        base->libc_used = libc_used;
+        base->lv_mem_frag = stats.lv_mem_frag;
+    } else if (index > SOAK_WARMUP_SAMPLES) {
+        if (stats.lv_mem_used > base->lv_mem_used)
+            fail("lv_mem grew %u -> %u", (unsigned)base->lv_mem_used, (unsigned)stats.lv_mem_used);
+        if (libc_used > base->libc_used)
+            fail("libc heap grew %u -> %u", (unsigned)base->libc_used, (unsigned)libc_used);
+        if (stats.lv_mem_frag > base->lv_mem_frag)
+            fail("lv_mem fragmentation grew %u%% -> %u%%", (unsigned)base->lv_mem_frag,
+                 (unsigned)stats.lv_mem_frag);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t steps = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+    seed = argc > 2 ? strtoul(argv[2], NULL, 0) : 1;
+    rnd_state = seed != 0 ? seed : 1;
+    printf("[soak] steps %u seed %u\n", (unsigned)steps, (unsigned)seed);
+
+    lv_init();
+    disp_init();
+    if (!page_manager_init())
+        fail("page_manager_init failed");
+
+    SOAK_PAGE_BIND(0);
+    SOAK_PAGE_BIND(1);
+    SOAK_PAGE_BIND(2);
+    SOAK_PAGE_BIND(3);
+    SOAK_PAGE_BIND(4);
+    SOAK_PAGE_BIND(5);
+    for (int i = 0; i < SOAK_PAGE_CNT; i++) {
+        snprintf(pages[i].name, sizeof(pages[i].name), "page%d", i);
+        pages[i].desc.save_state = save_state;
+        pages[i].desc.restore_state = restore_state;
+        install_page(i);
+    }
+
+    soak_sample base = {0};
+    uint32_t sample_cnt = 0;
+    for (step = 0; step < steps; step++) {
+        uint32_t r = rnd() % 100;
+        if (r < 40)
+            op_push();
+        else if (r < 75)
+            op_pop();
+        else if (r < 85)
+            op_replace();
+        else if (r < 92)
+            op_uninstall();
+        else if (r < 97)
+            op_scroll();
+        else
+            op_restore();
+
+        // 下一个操作可能落在动画过程中
+        advance(rnd() % 8);
+        if (!page_manager_check())
+            fail("page_manager_check failed");
+        if (lv_anim_count_running() == 0)
+            check_settled();
+        if (step % SOAK_SAMPLE_STEPS == SOAK_SAMPLE_STEPS - 1)
+            sample(++sample_cnt, &base);
+    }
+
+    printf("[soak] PASS\n");
+    return 0;
+}